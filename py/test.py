@@ -126,6 +126,39 @@ def test_hier_signal(language):
     assert product_port == product_hier, f"product mismatch: port={product_port} hier={product_hier}"
 
 
+@pytest.mark.parametrize("language", ["VHDL", "Verilog"])
+def test_scope_tree(language):
+    if language == "VHDL":
+        xsi = pyxsi.XSI("xsim.dir/widget/xsimk.so")
+        prefix = "widget"
+    else:
+        xsi = pyxsi.XSI("xsim.dir/counter_verilog/xsimk.so")
+        prefix = "counter_verilog"
+
+    assert f"/{prefix}" in xsi.children("/")
+
+    signals = xsi.signals(f"/{prefix}")
+    assert f"/{prefix}/sum" in signals
+    assert signals == sorted(signals)
+    assert sorted(xsi.list_signals()) == xsi.list_signals()
+
+    # Paging through results one at a time visits everything once
+    paged = []
+    while page := xsi.signals(f"/{prefix}", after=paged[-1] if paged else "", limit=1):
+        paged += page
+    assert paged == signals
+
+    assert xsi.find(f"/{prefix}/su*") == [f"/{prefix}/sum"]
+
+    # Globs don't descend into subscopes
+    assert xsi.find("/*") == []
+    assert xsi.find("/*/sum") == [f"/{prefix}/sum"]
+    assert xsi.find(f"^/{prefix}/(sum|product)$", regex=True) == [
+        f"/{prefix}/product",
+        f"/{prefix}/sum",
+    ]
+
+
 @pytest.mark.parametrize("language", ["VHDL", "Verilog"])
 def test_random(language):
     if language == "VHDL":
@@ -162,6 +195,164 @@ def test_random(language):
         (old_a, old_b) = (a, b)
 
 
+@pytest.mark.parametrize("language", ["VHDL", "Verilog"])
+def test_coverage(language, tmp_path):
+    if language == "VHDL":
+        xsi = pyxsi.XSI("xsim.dir/widget/xsimk.so")
+        prefix = "widget"
+    else:
+        xsi = pyxsi.XSI("xsim.dir/counter_verilog/xsimk.so")
+        prefix = "counter_verilog"
+
+    cov = xsi.coverage("clk")
+    assert cov.add(f"/{prefix}/*", bins=16) > 0
+
+    cycles = 1000
+    for n in range(cycles):
+        xsi.set_value("clk", 1)
+        xsi.run(HALF_PERIOD)
+        xsi.set_value("clk", 0)
+        xsi.run(HALF_PERIOD)
+
+        xsi.set_value("a", random.randint(0, 65535))
+        xsi.set_value("b", random.randint(0, 65535))
+
+    assert cov.samples == cycles
+
+    # Edges are counted from the clock's level after a restart
+    xsi.restart()
+    xsi.set_value("clk", 0)
+    xsi.run(HALF_PERIOD)
+    xsi.set_value("clk", 1)
+    xsi.run(HALF_PERIOD)
+    assert cov.samples == cycles + 1
+
+    report = cov.report()
+    a = report[f"/{prefix}/a"]
+    assert a.width == 16
+    assert a.untoggled == []
+    assert sum(a.hist) + a.unknown == cov.samples
+
+    # Reports from several processes accumulate
+    path = str(tmp_path / "coverage.txt")
+    cov.save(path)
+    cov.save(path, merge=True)
+
+    merged = pyxsi.Coverage()
+    merged.merge(path)
+    assert merged.samples == 2 * cov.samples
+    assert merged.report()[f"/{prefix}/a"].hist == [2 * h for h in a.hist]
+
+
+def test_coverage_malformed(tmp_path):
+    path = tmp_path / "coverage.txt"
+    path.write_text(
+        "pyxsi-coverage 1\nsamples 5\npoint /top/a 8 2 0\nrose ff\nfell 1\nhist 2 3\n"
+    )
+    cov = pyxsi.Coverage()
+    cov.merge(str(path))
+
+    # Truncated, garbled, or conflicting reports are rejected whole
+    for bad in [
+        "pyxsi-coverage 1\nsamples 5\npoint /top/b 8 2 0\nrose ff\nfell 1\nhist 1\n",
+        "pyxsi-coverage 1\nsamples 5\npoint /top/b 8 2 0\nrose fz\nfell 1\nhist 1 1\n",
+        "pyxsi-coverage 1\nsamples 5\npoint /top/b 8 2 0\nrose 1\nfell 1\nhist 1 1\n"
+        "point /top/a 9 2 0\nrose 1\nfell 1\nhist 1 1\n",
+        "pyxsi-coverage 1\nsamples 5\npoint /top/b 4294967295 0 0\nrose\nfell\nhist\n",
+        "pyxsi-coverage 1\nsamples 5\npoint /top/b 4294967304 2 0\nrose 1\nfell 1\nhist 1 1\n",
+        "pyxsi-coverage 1\nsamples 5\npoint /top/b 1 4 0\nrose 1\nfell 1\nhist 1 1 1 1\n",
+    ]:
+        path.write_text(bad)
+        with pytest.raises(RuntimeError, match="(?i)coverage"):
+            cov.merge(str(path))
+
+    assert cov.samples == 5
+    assert list(cov.report()) == ["/top/a"]
+    assert cov.report()["/top/a"].hist == [2, 3]
+
+
+@pytest.mark.parametrize("language", ["VHDL", "Verilog"])
+def test_record(language, tmp_path):
+    import json
+    import numpy as np
+
+    if language == "VHDL":
+        xsi = pyxsi.XSI("xsim.dir/widget/xsimk.so")
+        prefix = "widget"
+    else:
+        xsi = pyxsi.XSI("xsim.dir/counter_verilog/xsimk.so")
+        prefix = "counter_verilog"
+
+    path = tmp_path / "capture"
+    rec = xsi.record(str(path), clock="clk", chunk=100)
+    assert rec.add(f"/{prefix}/*") > 0
+
+    sums = []
+    cycles = 1000
+    for n in range(cycles):
+        xsi.set_value("clk", 1)
+        xsi.run(HALF_PERIOD)
+        xsi.set_value("clk", 0)
+        xsi.run(HALF_PERIOD)
+
+        xsi.set_value("a", random.randint(0, 65535))
+        xsi.set_value("b", random.randint(0, 65535))
+        sums.append(int(xsi.get_value("sum"), 2))
+
+    rec.close()
+
+    header = json.loads((path / "header.json").read_text())
+    columns = {c["name"]: c for c in header["columns"]}
+
+    def load(name, plane="file"):
+        c = columns[name]
+        return np.memmap(
+            path / c[plane], dtype=c["dtype"], mode="r", shape=tuple(c["shape"])
+        )
+
+    assert header["samples"] == rec.samples == cycles
+    assert columns[f"/{prefix}/sum"]["width"] == 16
+    assert list(load(f"/{prefix}/sum")) == sums
+    assert not load(f"/{prefix}/sum", "unknown").any()
+    assert list(np.diff(load("time"))) == [2 * HALF_PERIOD] * (cycles - 1)
+
+
+def test_record_writer_failure(tmp_path):
+    import resource
+    import signal
+    import time
+
+    xsi = pyxsi.XSI("xsim.dir/widget/xsimk.so")
+    rec = xsi.record(str(tmp_path / "capture"), clock="clk", chunk=10)
+    rec.add("/widget/sum")
+
+    def cycle():
+        xsi.set_value("clk", 1)
+        xsi.run(HALF_PERIOD)
+        xsi.set_value("clk", 0)
+        xsi.run(HALF_PERIOD)
+
+    # Capture files past 4 KiB fail with EFBIG instead of killing us
+    limit = resource.getrlimit(resource.RLIMIT_FSIZE)
+    signal.signal(signal.SIGXFSZ, signal.SIG_IGN)
+    resource.setrlimit(resource.RLIMIT_FSIZE, (4096, limit[1]))
+    try:
+        with pytest.raises(RuntimeError, match="File too large"):
+            for n in range(100000):
+                cycle()
+                if n % 10 == 0:
+                    time.sleep(0.001)  # let the writer catch up
+
+        # Once reported, the failure stops sampling rather than recurring
+        for n in range(100):
+            cycle()
+
+        with pytest.raises(RuntimeError, match="File too large"):
+            rec.close()
+    finally:
+        resource.setrlimit(resource.RLIMIT_FSIZE, limit)
+
+
 if __name__ == "__main__":
     import pytest
     import sys
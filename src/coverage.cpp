@@ -0,0 +1,322 @@
+#define FMT_HEADER_ONLY
+
+#include <bit>
+#include <charconv>
+#include <fstream>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <fmt/format.h>
+#include "coverage.h"
+
+using namespace Xsi;
+
+// Report file header; bump the version if the layout changes.
+static constexpr const char *coverage_magic = "pyxsi-coverage";
+static constexpr unsigned coverage_version = 1;
+
+// Value histograms are meant to stay small enough to keep on everywhere.
+static constexpr unsigned coverage_max_bins = 65536;
+
+// Widest signal a report may describe; guards against corrupt headers.
+static constexpr unsigned coverage_max_width = 1u << 24;
+
+static uint64_t extract_bits(const uint64_t *words, unsigned lo, unsigned count) {
+	if(count == 0)
+		return 0;
+	uint64_t x = words[lo/64] >> (lo&63);
+	if((lo&63) + count > 64)
+		x |= words[lo/64 + 1] << (64 - (lo&63));
+	return count == 64 ? x : x & ((1ULL << count) - 1);
+}
+
+static uint64_t read_number(std::istream &is, int base, const char *what, const std::string &path) {
+	std::string token;
+	uint64_t value = 0;
+	if(!(is >> token))
+		throw std::runtime_error(fmt::format(
+			"Malformed coverage report '{}': truncated {}", path, what));
+
+	auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), value, base);
+	if(ec != std::errc() || end != token.data() + token.size())
+		throw std::runtime_error(fmt::format(
+			"Malformed coverage report '{}': bad {} '{}'", path, what, token));
+	return value;
+}
+
+static void expect_token(std::istream &is, const char *expected, const std::string &path) {
+	std::string token;
+	if(!(is >> token) || token != expected)
+		throw std::runtime_error(fmt::format(
+			"Malformed coverage report '{}': expected '{}', got '{}'",
+			path, expected, token));
+}
+
+Coverage::Coverage(Loader *loader, const std::optional<std::string> &clock) :
+	_loader(loader)
+{
+	if(clock) {
+		if(!_loader)
+			throw std::invalid_argument("A clock requires a simulator to sample from.");
+		_clock.emplace(*_loader, *clock);
+	}
+}
+
+Coverage::Point &Coverage::_point(const std::string &name, unsigned width, unsigned bins) {
+	auto [it, inserted] = _points.try_emplace(name);
+	Point &p = it->second;
+
+	if(inserted) {
+		p.width = width;
+		p.bins = bins;
+		p.rose.assign((width + 63) / 64, 0);
+		p.fell.assign((width + 63) / 64, 0);
+		p.hist.assign(bins, 0);
+	} else if(p.width != width || p.bins != bins)
+		throw std::runtime_error(fmt::format(
+			"Coverage point '{}' is {} bits/{} bins here but {} bits/{} bins elsewhere.",
+			name, p.width, p.bins, width, bins));
+
+	return p;
+}
+
+size_t Coverage::add(const std::string &pattern, unsigned bins) {
+	if(!_loader)
+		throw std::runtime_error("Can't add signals without a simulator.");
+	if(bins > coverage_max_bins || (bins && !std::has_single_bit(bins)))
+		throw std::invalid_argument(fmt::format(
+			"Bin count must be zero or a power of two up to {}, not {}.",
+			coverage_max_bins, bins));
+
+	auto names = _loader->find(pattern);
+	if(names.empty())
+		throw std::runtime_error(fmt::format(
+			"No signals match '{}'.", pattern));
+
+	size_t added = 0;
+	for(const auto &name : names) {
+		auto probe = _loader->make_probe(name);
+
+		// Narrow signals can't use more bins than they have values.
+		unsigned b = bins;
+		if(probe.bit_width < 32)
+			b = std::min(b, 1u << probe.bit_width);
+
+		Point &p = _point(name, probe.bit_width, b);
+		if(p.probe)
+			continue;
+
+		p.prev.assign(probe.words(), 0);
+		p.prev_known.assign(probe.words(), 0);
+		if(probe.words() > _val.size()) {
+			_val.resize(probe.words());
+			_unk.resize(probe.words());
+		}
+		p.probe = std::move(probe);
+		added++;
+	}
+	return added;
+}
+
+void Coverage::sample() {
+	for(auto &[name, p] : _points) {
+		if(!p.probe)
+			continue;
+
+		_loader->read_probe(*p.probe, _val.data(), _unk.data());
+
+		bool any_unknown = false;
+		for(size_t w = 0; w < p.rose.size(); w++) {
+			uint64_t known = ~_unk[w] & p.prev_known[w];
+			p.rose[w] |= ~p.prev[w] & _val[w] & known;
+			p.fell[w] |= p.prev[w] & ~_val[w] & known;
+			p.prev[w] = _val[w];
+			p.prev_known[w] = ~_unk[w];
+			any_unknown |= !!_unk[w];
+		}
+
+		if(any_unknown)
+			p.unknown++;
+		else if(p.bins) {
+			unsigned k = std::countr_zero(p.bins);
+			p.hist[extract_bits(_val.data(), p.width - k, k)]++;
+		}
+	}
+	_samples++;
+}
+
+void Coverage::on_run() {
+	if(!_clock || _clock->rising())
+		sample();
+}
+
+void Coverage::reset() {
+	_samples = 0;
+	for(auto &[name, p] : _points) {
+		std::fill(p.rose.begin(), p.rose.end(), 0);
+		std::fill(p.fell.begin(), p.fell.end(), 0);
+		std::fill(p.hist.begin(), p.hist.end(), 0);
+		std::fill(p.prev_known.begin(), p.prev_known.end(), 0);
+		p.unknown = 0;
+	}
+}
+
+void Coverage::restart() {
+	if(_clock)
+		_clock->reset();
+	for(auto &[name, p] : _points)
+		std::fill(p.prev_known.begin(), p.prev_known.end(), 0);
+}
+
+std::map<std::string, Coverage::Summary> Coverage::report() const {
+	std::map<std::string, Summary> result;
+	for(const auto &[name, p] : _points) {
+		Summary s{p.width, 0, 0, {}, p.hist, p.unknown};
+		for(size_t w = 0; w < p.rose.size(); w++) {
+			s.rose += std::popcount(p.rose[w]);
+			s.fell += std::popcount(p.fell[w]);
+		}
+		for(unsigned n = 0; n < p.width; n++)
+			if(!((p.rose[n/64] & p.fell[n/64]) >> (n&63) & 1))
+				s.untoggled.push_back(n);
+		result.emplace(name, std::move(s));
+	}
+	return result;
+}
+
+void Coverage::_read_stream(std::istream &is, const std::string &path) {
+	expect_token(is, coverage_magic, path);
+	if(read_number(is, 10, "version", path) != coverage_version)
+		throw std::runtime_error(fmt::format(
+			"Coverage report '{}' has unsupported version.", path));
+
+	expect_token(is, "samples", path);
+	_samples += read_number(is, 10, "sample count", path);
+
+	std::string token;
+	while(is >> token) {
+		if(token != "point")
+			throw std::runtime_error(fmt::format(
+				"Malformed coverage report '{}': unexpected '{}'", path, token));
+
+		std::string name;
+		if(!(is >> name))
+			throw std::runtime_error(fmt::format(
+				"Malformed coverage report '{}': truncated point header", path));
+		// Check before narrowing, so oversized values can't wrap.
+		uint64_t width = read_number(is, 10, "width", path);
+		uint64_t bins = read_number(is, 10, "bin count", path);
+		if(width == 0 || width > coverage_max_width
+				|| bins > coverage_max_bins || (bins && !std::has_single_bit(bins))
+				|| (width < 64 && bins > (1ULL << width)))
+			throw std::runtime_error(fmt::format(
+				"Malformed coverage report '{}': bad shape for '{}'", path, name));
+
+		Point &p = _point(name, (unsigned)width, (unsigned)bins);
+		p.unknown += read_number(is, 10, "unknown count", path);
+
+		expect_token(is, "rose", path);
+		for(auto &w : p.rose)
+			w |= read_number(is, 16, "toggle word", path);
+		expect_token(is, "fell", path);
+		for(auto &w : p.fell)
+			w |= read_number(is, 16, "toggle word", path);
+		expect_token(is, "hist", path);
+		for(auto &c : p.hist)
+			c += read_number(is, 10, "bin count", path);
+	}
+}
+
+void Coverage::_absorb(const Coverage &other) {
+	// Check every point before touching any, so a conflict leaves us as we were.
+	for(const auto &[name, q] : other._points) {
+		auto it = _points.find(name);
+		if(it != _points.end() && (it->second.width != q.width || it->second.bins != q.bins))
+			throw std::runtime_error(fmt::format(
+				"Coverage point '{}' is {} bits/{} bins here but {} bits/{} bins elsewhere.",
+				name, it->second.width, it->second.bins, q.width, q.bins));
+	}
+
+	for(const auto &[name, q] : other._points) {
+		Point &p = _point(name, q.width, q.bins);
+		for(size_t w = 0; w < p.rose.size(); w++) {
+			p.rose[w] |= q.rose[w];
+			p.fell[w] |= q.fell[w];
+		}
+		for(size_t b = 0; b < p.hist.size(); b++)
+			p.hist[b] += q.hist[b];
+		p.unknown += q.unknown;
+	}
+	_samples += other._samples;
+}
+
+void Coverage::_write_stream(std::ostream &os) const {
+	os << fmt::format("{} {}\nsamples {}\n", coverage_magic, coverage_version, _samples);
+	for(const auto &[name, p] : _points) {
+		os << fmt::format("point {} {} {} {}\nrose", name, p.width, p.bins, p.unknown);
+		for(auto w : p.rose)
+			os << fmt::format(" {:x}", w);
+		os << "\nfell";
+		for(auto w : p.fell)
+			os << fmt::format(" {:x}", w);
+		os << "\nhist";
+		for(auto c : p.hist)
+			os << fmt::format(" {}", c);
+		os << "\n";
+	}
+}
+
+void Coverage::merge(const std::string &path) {
+	std::ifstream is(path);
+	if(!is)
+		throw std::runtime_error(fmt::format(
+			"Unable to open coverage report '{}'", path));
+
+	// Parse in full before merging, so a bad report changes nothing.
+	Coverage report;
+	report._read_stream(is, path);
+	_absorb(report);
+}
+
+void Coverage::save(const std::string &path, bool merge) const {
+	// Serialize concurrent writers (e.g. forked pytest workers) through a
+	// side lock file; the report itself is replaced atomically by rename.
+	std::string lock_path = path + ".lock";
+	int lock_fd = open(lock_path.c_str(), O_RDWR|O_CREAT|O_CLOEXEC, 0666);
+	if(lock_fd < 0 || flock(lock_fd, LOCK_EX) < 0) {
+		if(lock_fd >= 0)
+			close(lock_fd);
+		throw std::runtime_error(fmt::format(
+			"Unable to lock coverage report '{}'", lock_path));
+	}
+
+	std::string tmp_path = fmt::format("{}.{}.tmp", path, getpid());
+	try {
+		Coverage total(*this);
+		if(merge) {
+			std::ifstream is(path);
+			if(is) {
+				Coverage report;
+				report._read_stream(is, path);
+				total._absorb(report);
+			}
+		}
+
+		{
+			std::ofstream os(tmp_path);
+			total._write_stream(os);
+			if(!os.flush())
+				throw std::runtime_error(fmt::format(
+					"Unable to write coverage report '{}'", tmp_path));
+		}
+		if(rename(tmp_path.c_str(), path.c_str()) < 0)
+			throw std::runtime_error(fmt::format(
+				"Unable to replace coverage report '{}'", path));
+	} catch(...) {
+		// Don't leave a half-written report behind (it may not exist yet).
+		unlink(tmp_path.c_str());
+		close(lock_fd);
+		throw;
+	}
+	close(lock_fd);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "xsi_loader.h"
+
+#include <map>
+#include <optional>
+
+namespace Xsi {
+	// Toggle and value-bin coverage over hierarchical signals.
+	//
+	// Signals are sampled natively after every run() of the simulator,
+	// or only on each rising edge of a clock if one is given (see
+	// on_run()), or explicitly via sample(). Each bit records whether it
+	// has been seen to rise (0->1) and fall (1->0); each signal also keeps
+	// a histogram over its top log2(bins) bits. Results can be saved to a
+	// text report and merged with reports from other processes.
+	class Coverage {
+		public:
+			struct Summary {
+				unsigned width;
+				unsigned rose;		// bits seen 0->1
+				unsigned fell;		// bits seen 1->0
+				std::vector<unsigned> untoggled;
+				std::vector<uint64_t> hist;
+				uint64_t unknown;	// samples with X/Z bits
+			};
+
+			// A collector without a loader can only merge and save reports.
+			Coverage(Loader *loader=nullptr, const std::optional<std::string> &clock=std::nullopt);
+
+			// Register every find() glob match; returns the number added.
+			size_t add(const std::string &pattern, unsigned bins=16);
+
+			void sample();
+
+			// Called after each run(): samples on a rising clock edge, or
+			// every time if there is no clock.
+			void on_run();
+			void reset();
+
+			// Forget the last sampled levels, e.g. after the simulator
+			// restarts; accumulated coverage is kept.
+			void restart();
+
+			void merge(const std::string &path);
+			void save(const std::string &path, bool merge=false) const;
+
+			uint64_t samples() const { return _samples; }
+			std::map<std::string, Summary> report() const;
+
+		private:
+			struct Point {
+				unsigned width = 0;
+				unsigned bins = 0;
+				std::vector<uint64_t> rose, fell;
+				std::vector<uint64_t> hist;
+				uint64_t unknown = 0;
+
+				// Only present for signals registered in this process
+				std::optional<Loader::Probe> probe;
+				std::vector<uint64_t> prev, prev_known;
+			};
+
+			Point &_point(const std::string &name, unsigned width, unsigned bins);
+			void _read_stream(std::istream &is, const std::string &path);
+			void _absorb(const Coverage &other);
+			void _write_stream(std::ostream &os) const;
+
+			Loader *_loader;
+			std::optional<Loader::EdgeDetector> _clock;
+
+			uint64_t _samples = 0;
+			std::map<std::string, Point> _points;
+			std::vector<uint64_t> _val, _unk;
+	};
+}
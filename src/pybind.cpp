@@ -5,6 +5,8 @@
 #include <pybind11/stl.h>
 
 #include "xsi_loader.h"
+#include "coverage.h"
+#include "recorder.h"
 
 namespace py = pybind11;
 using namespace std;
@@ -54,6 +56,8 @@ class XSI {
 
 		void restart() {
 			loader->restart();
+			for_each_sampler(coverage, [](auto &cov) { cov.restart(); });
+			for_each_sampler(recorders, [](auto &rec) { rec.restart(); });
 		}
 
 		const int get_status() {
@@ -66,6 +70,8 @@ class XSI {
 
 		void run(int const& duration) {
 			loader->run(duration);
+			for_each_sampler(coverage, [](auto &cov) { cov.on_run(); });
+			for_each_sampler(recorders, [](auto &rec) { rec.on_run(); });
 		}
 
 		const int get_port_count() const {
@@ -92,8 +98,50 @@ class XSI {
 			return loader->list_signals();
 		}
 
+		std::vector<std::string> children(const std::string &scope,
+				const std::string &after, size_t limit) {
+			return loader->children(scope, after, limit);
+		}
+
+		std::vector<std::string> signals(const std::string &scope,
+				const std::string &after, size_t limit) {
+			return loader->signals(scope, after, limit);
+		}
+
+		std::vector<std::string> find(const std::string &pattern, bool regex,
+				const std::string &after, size_t limit) {
+			return loader->find(pattern, regex, after, limit);
+		}
+
+		std::shared_ptr<Xsi::Coverage> add_coverage(const std::optional<std::string> &clock) {
+			auto cov = std::make_shared<Xsi::Coverage>(loader.get(), clock);
+			coverage.push_back(cov);
+			return cov;
+		}
+
+		std::shared_ptr<Xsi::Recorder> add_recorder(const std::string &path,
+				const std::optional<std::string> &clock, size_t chunk, bool unknown) {
+			auto rec = std::make_shared<Xsi::Recorder>(loader.get(), path, clock, chunk, unknown);
+			recorders.push_back(rec);
+			return rec;
+		}
+
 	private:
+		// Samplers are only referenced weakly: once Python drops one, it
+		// stops being sampled and is forgotten on the next visit.
+		template<typename T, typename F>
+		static void for_each_sampler(std::vector<std::weak_ptr<T>> &samplers, F f) {
+			std::erase_if(samplers, [&](auto &sampler) {
+				auto s = sampler.lock();
+				if(s)
+					f(*s);
+				return !s;
+			});
+		}
+
 		std::unique_ptr<Xsi::Loader> loader;
+		std::vector<std::weak_ptr<Xsi::Coverage>> coverage;
+		std::vector<std::weak_ptr<Xsi::Recorder>> recorders;
 		s_xsi_setup_info info;
 
 		const std::string design_so;
@@ -103,6 +151,30 @@ class XSI {
 };
 
 PYBIND11_MODULE(pyxsi, m) {
+	py::class_<Xsi::Coverage::Summary>(m, "CoverageSummary")
+		.def_readonly("width", &Xsi::Coverage::Summary::width)
+		.def_readonly("rose", &Xsi::Coverage::Summary::rose)
+		.def_readonly("fell", &Xsi::Coverage::Summary::fell)
+		.def_readonly("untoggled", &Xsi::Coverage::Summary::untoggled)
+		.def_readonly("hist", &Xsi::Coverage::Summary::hist)
+		.def_readonly("unknown", &Xsi::Coverage::Summary::unknown);
+
+	py::class_<Xsi::Coverage, std::shared_ptr<Xsi::Coverage>>(m, "Coverage")
+		.def(py::init([]() { return std::make_shared<Xsi::Coverage>(); }))
+		.def("add", &Xsi::Coverage::add, py::arg("pattern"), py::arg("bins")=16)
+		.def("sample", &Xsi::Coverage::sample)
+		.def("reset", &Xsi::Coverage::reset)
+		.def("merge", &Xsi::Coverage::merge, py::arg("path"))
+		.def("save", &Xsi::Coverage::save, py::arg("path"), py::arg("merge")=false)
+		.def("report", &Xsi::Coverage::report)
+		.def_property_readonly("samples", &Xsi::Coverage::samples);
+
+	py::class_<Xsi::Recorder, std::shared_ptr<Xsi::Recorder>>(m, "Recorder")
+		.def("add", &Xsi::Recorder::add, py::arg("pattern"))
+		.def("sample", &Xsi::Recorder::sample)
+		.def("close", &Xsi::Recorder::close)
+		.def_property_readonly("samples", &Xsi::Recorder::samples);
+
 	py::class_<XSI>(m, "XSI")
 		.def(py::init<std::string const&, std::string const&, std::optional<std::string> const&, std::optional<std::string> const&>(),
 				py::arg("design_so"),
@@ -119,6 +191,20 @@ PYBIND11_MODULE(pyxsi, m) {
 		.def("get_status", &XSI::get_status)
 		.def("get_error_info", &XSI::get_error_info)
 		.def("list_signals", &XSI::list_signals)
+		.def("children", &XSI::children, py::arg("scope")="/",
+			py::arg("after")="", py::arg("limit")=0)
+		.def("signals", &XSI::signals, py::arg("scope")="/",
+			py::arg("after")="", py::arg("limit")=0)
+		.def("find", &XSI::find, py::arg("pattern"), py::arg("regex")=false,
+			py::arg("after")="", py::arg("limit")=0,
+			"Signals matching a glob, where '*' and '?' don't cross '/', or a regex.")
+		.def("coverage", &XSI::add_coverage, py::arg("clock")=std::nullopt,
+			py::keep_alive<0, 1>(),
+			"Collect coverage after every run(), or only on rising edges of clock.")
+		.def("record", &XSI::add_recorder, py::arg("path"),
+			py::arg("clock")=std::nullopt, py::arg("chunk")=65536,
+			py::arg("unknown")=true, py::keep_alive<0, 1>(),
+			"Record a sample after every run(), or only on rising edges of clock.")
 		.def("run", &XSI::run, py::arg("duration")=0,
 			py::call_guard<py::gil_scoped_release>());
 }
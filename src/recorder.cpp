@@ -0,0 +1,300 @@
+#define FMT_HEADER_ONLY
+
+#include <cerrno>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <fmt/format.h>
+#include "recorder.h"
+
+using namespace Xsi;
+
+// header.json layout; bump the version if it changes.
+static constexpr unsigned recorder_version = 1;
+
+static size_t item_size_for(unsigned width) {
+	if(width <= 8) return 1;
+	if(width <= 16) return 2;
+	if(width <= 32) return 4;
+	return ((width + 63) / 64) * 8;
+}
+
+static std::string json_escape(const std::string &s) {
+	std::string out;
+	for(char c : s) {
+		if(c == '"' || c == '\\')
+			out += '\\';
+		out += c;
+	}
+	return out;
+}
+
+Recorder::Recorder(Loader *loader, const std::string &path,
+		const std::optional<std::string> &clock, size_t chunk_samples, bool unknown) :
+	_loader(loader),
+	_path(path),
+	_chunk_samples(chunk_samples),
+	_unknown(unknown)
+{
+	if(_chunk_samples == 0)
+		throw std::invalid_argument("Chunk size must be at least one sample.");
+
+	if(mkdir(_path.c_str(), 0777) < 0 && errno != EEXIST)
+		throw std::runtime_error(fmt::format(
+			"Unable to create capture directory '{}': {}", _path, strerror(errno)));
+
+	if(clock) {
+		_clock.emplace(*_loader, *clock);
+	}
+
+	_columns.push_back({"time", "time.bin", 64, sizeof(uint64_t)});
+}
+
+Recorder::~Recorder() {
+	try {
+		close();
+	} catch(...) {
+		/* nowhere to report it from a destructor */
+	}
+}
+
+size_t Recorder::add(const std::string &pattern) {
+	if(_started || _closed)
+		throw std::runtime_error("Signals must be added before recording starts.");
+
+	auto names = _loader->find(pattern);
+	if(names.empty())
+		throw std::runtime_error(fmt::format(
+			"No signals match '{}'.", pattern));
+
+	for(const auto &name : names) {
+		auto probe = _loader->make_probe(name);
+		if(probe.words() > _val.size()) {
+			_val.resize(probe.words());
+			_unk.resize(probe.words());
+		}
+		size_t n = _columns.size();
+		_columns.push_back({name, fmt::format("{:04}.bin", n),
+			probe.bit_width, item_size_for(probe.bit_width), std::move(probe),
+			_unknown ? fmt::format("{:04}.unk.bin", n) : ""});
+	}
+	return names.size();
+}
+
+std::unique_ptr<Recorder::Chunk> Recorder::_new_chunk() const {
+	auto chunk = std::make_unique<Chunk>();
+	for(const auto &col : _columns) {
+		chunk->cols.emplace_back(_chunk_samples * col.item_size);
+		chunk->unks.emplace_back(col.unk_file.empty() ? 0 : _chunk_samples * col.item_size);
+	}
+	return chunk;
+}
+
+void Recorder::_start() {
+	_staging = _new_chunk();
+
+	// Files are created on the writer thread, off the simulation's path.
+	_started = true;
+	_thread = std::thread(&Recorder::_writer, this);
+}
+
+void Recorder::_open_files() {
+	auto create = [this](const std::string &name) {
+		std::string file = _path + "/" + name;
+		int fd = open(file.c_str(), O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC, 0666);
+		if(fd < 0)
+			throw std::runtime_error(fmt::format(
+				"Unable to create capture file '{}': {}", file, strerror(errno)));
+		return fd;
+	};
+
+	for(auto &col : _columns) {
+		col.fd = create(col.file);
+		if(!col.unk_file.empty())
+			col.unk_fd = create(col.unk_file);
+	}
+	_write_header(0);
+}
+
+void Recorder::_close_files() {
+	for(auto &col : _columns) {
+		if(col.fd >= 0)
+			::close(col.fd);
+		if(col.unk_fd >= 0)
+			::close(col.unk_fd);
+		col.fd = col.unk_fd = -1;
+	}
+}
+
+void Recorder::sample() {
+	if(_closed)
+		throw std::runtime_error("Recorder is closed.");
+	if(_failed)
+		std::rethrow_exception(_error);
+	if(!_started)
+		_start();
+
+	size_t row = _staging->rows;
+	uint64_t now = _loader->time();
+	memcpy(_staging->cols[0].data() + row * sizeof(uint64_t), &now, sizeof(uint64_t));
+
+	for(size_t n = 1; n < _columns.size(); n++) {
+		auto &col = _columns[n];
+		_loader->read_probe(*col.probe, _val.data(), _unk.data());
+		memcpy(_staging->cols[n].data() + row * col.item_size, _val.data(), col.item_size);
+		if(!col.unk_file.empty())
+			memcpy(_staging->unks[n].data() + row * col.item_size, _unk.data(), col.item_size);
+	}
+
+	_samples++;
+	if(++_staging->rows == _chunk_samples)
+		_submit();
+}
+
+void Recorder::on_run() {
+	// A failed writer was already reported once; close() reports it again.
+	if(_closed || _failed)
+		return;
+
+	if(!_clock || _clock->rising())
+		sample();
+}
+
+void Recorder::_submit() {
+	std::unique_ptr<Chunk> next;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(_error) {
+			// The staging chunk stays full; stop sampling into it.
+			_failed = true;
+			std::rethrow_exception(_error);
+		}
+		_full.push_back(std::move(_staging));
+		if(!_free.empty()) {
+			next = std::move(_free.front());
+			_free.pop_front();
+		}
+	}
+	_cv.notify_one();
+
+	// Writer is behind: grow the pool rather than stall the simulation.
+	_staging = next ? std::move(next) : _new_chunk();
+}
+
+void Recorder::_writer() {
+	try {
+		_open_files();
+
+		uint64_t rows = 0;
+		for(;;) {
+			std::unique_ptr<Chunk> chunk;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_cv.wait(lock, [this] { return _stop || !_full.empty(); });
+				if(_full.empty())
+					break;
+				chunk = std::move(_full.front());
+				_full.pop_front();
+			}
+
+			_write_chunk(*chunk, rows);
+			rows += chunk->rows;
+			_write_header(rows);
+
+			chunk->rows = 0;
+			std::lock_guard<std::mutex> lock(_mutex);
+			_free.push_back(std::move(chunk));
+		}
+	} catch(...) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_error = std::current_exception();
+	}
+	_close_files();
+}
+
+void Recorder::_write_rows(int fd, const std::string &file, size_t offset,
+		const unsigned char *data, size_t length) {
+	static const size_t page = sysconf(_SC_PAGESIZE);
+	size_t map_offset = offset - offset % page;
+	size_t map_length = offset + length - map_offset;
+
+	if(ftruncate(fd, offset + length) < 0)
+		throw std::runtime_error(fmt::format(
+			"Unable to extend capture file '{}': {}", file, strerror(errno)));
+
+	void *map = mmap(nullptr, map_length, PROT_READ|PROT_WRITE, MAP_SHARED, fd, map_offset);
+	if(map == MAP_FAILED)
+		throw std::runtime_error(fmt::format(
+			"Unable to map capture file '{}': {}", file, strerror(errno)));
+
+	memcpy((char*)map + (offset - map_offset), data, length);
+	munmap(map, map_length);
+}
+
+void Recorder::_write_chunk(const Chunk &chunk, uint64_t first_row) {
+	for(size_t n = 0; n < _columns.size(); n++) {
+		const auto &col = _columns[n];
+		size_t offset = first_row * col.item_size;
+		size_t length = chunk.rows * col.item_size;
+
+		_write_rows(col.fd, col.file, offset, chunk.cols[n].data(), length);
+		if(!col.unk_file.empty())
+			_write_rows(col.unk_fd, col.unk_file, offset, chunk.unks[n].data(), length);
+	}
+}
+
+void Recorder::_write_header(uint64_t rows) const {
+	std::string header = fmt::format(
+		"{{\n  \"version\": {},\n  \"samples\": {},\n  \"columns\": [",
+		recorder_version, rows);
+
+	for(size_t n = 0; n < _columns.size(); n++) {
+		const auto &col = _columns[n];
+		std::string shape = col.item_size > 8
+			? fmt::format("[{}, {}]", rows, col.item_size / 8)
+			: fmt::format("[{}]", rows);
+		std::string unknown = col.unk_file.empty() ? ""
+			: fmt::format(", \"unknown\": \"{}\"", col.unk_file);
+		header += fmt::format(
+			"{}\n    {{\"name\": \"{}\", \"file\": \"{}\"{}, \"width\": {}, "
+			"\"dtype\": \"<u{}\", \"shape\": {}}}",
+			n ? "," : "", json_escape(col.name), col.file, unknown, col.width,
+			std::min<size_t>(col.item_size, 8), shape);
+	}
+	header += "\n  ]\n}\n";
+
+	std::string file = _path + "/header.json";
+	std::string tmp_file = file + ".tmp";
+	{
+		std::ofstream os(tmp_file);
+		os << header;
+		if(!os.flush())
+			throw std::runtime_error(fmt::format(
+				"Unable to write capture header '{}'", tmp_file));
+	}
+	if(rename(tmp_file.c_str(), file.c_str()) < 0)
+		throw std::runtime_error(fmt::format(
+			"Unable to replace capture header '{}'", file));
+}
+
+void Recorder::close() {
+	if(_closed)
+		return;
+	if(!_started)
+		_start();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(!_failed && _staging->rows)
+			_full.push_back(std::move(_staging));
+		_stop = true;
+	}
+	_cv.notify_one();
+	_thread.join();
+	_closed = true;
+
+	if(_error)
+		std::rethrow_exception(_error);
+}
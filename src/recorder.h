@@ -0,0 +1,100 @@
+#pragma once
+
+#include "xsi_loader.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace Xsi {
+	// Streaming capture of hierarchical signals to disk.
+	//
+	// Each signal becomes one raw little-endian column file in the output
+	// directory (uint8/16/32/64 by width, or rows of uint64 words for wider
+	// signals), plus a "time" column. X/Z/U bits read as 0 in the value
+	// file; unless disabled, a second "unknown" file of the same shape
+	// flags them. header.json describes every column's files, dtype and
+	// shape so they can be opened with numpy.memmap.
+	//
+	// Samples are staged in memory and handed to a background thread in
+	// chunks; the writer extends and maps each file a chunk at a time.
+	// The simulation side never waits on disk I/O: if the writer falls
+	// behind, more staging chunks are allocated.
+	class Recorder {
+		public:
+			Recorder(Loader *loader, const std::string &path,
+				const std::optional<std::string> &clock=std::nullopt,
+				size_t chunk_samples=65536, bool unknown=true);
+			~Recorder();
+
+			// Register every find() glob match; only before the first sample.
+			size_t add(const std::string &pattern);
+
+			void sample();
+
+			// Called after each run(): samples on a rising clock edge, or
+			// every time if there is no clock.
+			void on_run();
+			void close();
+
+			// Re-read the clock's level after the simulator restarts.
+			void restart() { if(_clock) _clock->reset(); }
+
+			uint64_t samples() const { return _samples; }
+
+		private:
+			struct Column {
+				std::string name;
+				std::string file;
+				unsigned width;
+				size_t item_size;	// bytes per sample
+				std::optional<Loader::Probe> probe;	// empty for "time"
+				std::string unk_file;	// empty without an unknown plane
+				int fd = -1, unk_fd = -1;
+			};
+
+			struct Chunk {
+				size_t rows = 0;
+				std::vector<std::vector<unsigned char>> cols;
+				std::vector<std::vector<unsigned char>> unks;	// empty where no plane
+			};
+
+			std::unique_ptr<Chunk> _new_chunk() const;
+
+			void _start();
+			void _open_files();
+			void _close_files();
+			void _writer();
+			void _write_chunk(const Chunk &chunk, uint64_t first_row);
+			void _write_rows(int fd, const std::string &file, size_t offset,
+				const unsigned char *data, size_t length);
+			void _write_header(uint64_t rows) const;
+			void _submit();
+
+			Loader *_loader;
+			std::string _path;
+			std::optional<Loader::EdgeDetector> _clock;
+			size_t _chunk_samples;
+			bool _unknown;
+
+			std::vector<Column> _columns;
+			std::vector<uint64_t> _val, _unk;
+			uint64_t _samples = 0;
+			bool _started = false, _closed = false, _failed = false;
+
+			// Staging chunk filled by the simulation thread
+			std::unique_ptr<Chunk> _staging;
+
+			// Shared with the writer thread
+			std::mutex _mutex;
+			std::condition_variable _cv;
+			std::deque<std::unique_ptr<Chunk>> _full, _free;
+			bool _stop = false;
+			std::exception_ptr _error;
+			std::thread _thread;
+	};
+}
@@ -1,6 +1,10 @@
 #define FMT_HEADER_ONLY
 
 #include <cxxabi.h>
+#include <fnmatch.h>
+#include <algorithm>
+#include <optional>
+#include <regex>
 #include <fmt/format.h>
 #include "xsi_loader.h"
 
@@ -262,6 +266,8 @@ void Loader::init_hierarchy() {
 
 	if(_name_to_id.empty())
 		throw std::runtime_error("No signals found in hierarchy database.");
+
+	build_index();
 }
 
 void Loader::enumerate_scope(unsigned scope_id) {
@@ -273,6 +279,8 @@ void Loader::enumerate_scope(unsigned scope_id) {
 	unsigned first_child_scope = *(unsigned*)((char*)scopeInfo + iki_ScopeInfo_first_child_scope);
 	unsigned first_child_obj   = *(unsigned*)((char*)scopeInfo + iki_ScopeInfo_first_child_obj);
 
+	auto &walk = _scope_walk[scope_id];
+
 	void *scopeCommon = _getScopeCommonInfo(_dbg, scopeInfo);
 	unsigned obj_count = 0;
 	if(scopeCommon)
@@ -287,7 +295,8 @@ void Loader::enumerate_scope(unsigned scope_id) {
 		std::string name;
 		_getObjectLongName(&name, _dbg, obj_id);
 		if(!name.empty()) {
-			_name_to_id[name] = obj_id;
+			auto [it, inserted] = _name_to_id.insert_or_assign(name, obj_id);
+			walk.objects.push_back(it->first);
 
 			if(scope_id == 1) {
 				auto last_slash = name.rfind('/');
@@ -298,11 +307,92 @@ void Loader::enumerate_scope(unsigned scope_id) {
 		}
 	}
 
-	for(unsigned i = 0; i < child_scope_count; ++i)
+	for(unsigned i = 0; i < child_scope_count; ++i) {
+		walk.children.push_back(first_child_scope + i);
 		enumerate_scope(first_child_scope + i);
+	}
 }
 
-std::string Loader::get_signal_value(const std::string &name) {
+static std::string_view parent_scope(std::string_view path) {
+	auto slash = path.rfind('/');
+	return slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+}
+
+// Does "member" sit somewhere below scope path "scope"?
+static bool within_scope(std::string_view member, std::string_view scope) {
+	return member.size() > scope.size() && member.starts_with(scope)
+		&& member[scope.size()] == '/';
+}
+
+void Loader::_name_scope(unsigned id, std::unordered_map<unsigned, std::string> &paths) {
+	// The database doesn't name scopes, so use the longest path that
+	// all of this scope's objects and child scopes sit below. A '/'
+	// inside one member's leaf name is outvoted by the others.
+	const auto &walk = _scope_walk.at(id);
+	std::optional<std::string_view> path;
+	auto narrow = [&](std::string_view member) {
+		if(!path)
+			path = parent_scope(member);
+		while(!path->empty() && !within_scope(member, *path))
+			path = parent_scope(*path);
+	};
+
+	for(auto child : walk.children) {
+		_name_scope(child, paths);
+		if(auto it = paths.find(child); it != paths.end())
+			narrow(it->second);
+	}
+	for(auto name : walk.objects)
+		narrow(name);
+
+	// Scopes with neither objects nor named children stay anonymous.
+	if(path && !path->empty())
+		paths.emplace(id, std::string(*path));
+}
+
+void Loader::build_index() {
+	_sorted_names.clear();
+	_sorted_names.reserve(_name_to_id.size());
+	for(const auto &[name, id] : _name_to_id)
+		_sorted_names.emplace_back(name);
+	std::sort(_sorted_names.begin(), _sorted_names.end());
+
+	// Shape the tree after the scope walk, not after splitting names.
+	std::unordered_map<unsigned, std::string> paths;
+	_name_scope(1, paths);
+
+	_scopes.clear();
+	_scopes.try_emplace("");
+	for(const auto &[id, path] : paths)
+		_scopes.try_emplace(path);
+
+	for(const auto &[id, walk] : _scope_walk) {
+		auto pit = paths.find(id);
+		if(pit == paths.end())
+			continue;
+
+		auto &node = _scopes.find(pit->second)->second;
+		node.signals.insert(node.signals.end(), walk.objects.begin(), walk.objects.end());
+		for(auto child : walk.children)
+			if(auto cit = paths.find(child); cit != paths.end() && cit->second != pit->second)
+				node.children.push_back(_scopes.find(cit->second)->first);
+	}
+
+	// The top scope hangs off an unnamed root
+	if(auto it = paths.find(1); it != paths.end())
+		_scopes[""].children.push_back(_scopes.find(it->second)->first);
+
+	for(auto &[path, node] : _scopes) {
+		for(auto *v : {&node.children, &node.signals}) {
+			std::sort(v->begin(), v->end());
+			v->erase(std::unique(v->begin(), v->end()), v->end());
+		}
+	}
+
+	_scope_walk.clear();
+}
+
+unsigned Loader::resolve_hier(const std::string &name) {
 	// Resolve bare port names to their hierarchical path
 	std::string resolved = name;
 	if(name.find('/') == std::string::npos) {
@@ -316,36 +406,115 @@ std::string Loader::get_signal_value(const std::string &name) {
 		throw std::runtime_error(fmt::format(
 			"Signal '{}' not found in hierarchy.", name));
 
-	return _read_hier_signal(it->second);
+	return it->second;
 }
 
-std::string Loader::_read_hier_signal(unsigned id) {
+std::string Loader::get_signal_value(const std::string &name) {
+	return _read_hier_signal(resolve_hier(name));
+}
+
+Loader::Probe Loader::_probe_for_id(unsigned id) {
 	void *objInfo = _getObjectInfo(_dbg, id);
 	if(!objInfo)
 		throw std::runtime_error(fmt::format(
 			"getObjectInfo returned null for object id {}", id));
 
-	alignas(8) unsigned char hdlObj[iki_HdlValueObject_size] = {};
-	_setHdlValueObject(_dbg, hdlObj, objInfo);
+	Probe probe;
+	probe.id = id;
+	probe.hdl.assign(iki_HdlValueObject_size, 0);
+	_setHdlValueObject(_dbg, probe.hdl.data(), objInfo);
 
-	unsigned format = *(unsigned*)(hdlObj + iki_HdlValueObject_format);
-	bool is_vhdl = (format == iki_HdlValueFormat_VHDL);
-	unsigned bit_width = *(unsigned*)(hdlObj + iki_HdlValueObject_bit_width);
-	if(bit_width == 0)
-		bit_width = 1;
+	unsigned format = *(unsigned*)(probe.hdl.data() + iki_HdlValueObject_format);
+	probe.is_vhdl = (format == iki_HdlValueFormat_VHDL);
+	probe.bit_width = *(unsigned*)(probe.hdl.data() + iki_HdlValueObject_bit_width);
+	if(probe.bit_width == 0)
+		probe.bit_width = 1;
 
-	size_t buf_size;
-	if(is_vhdl)
-		buf_size = bit_width;
+	if(probe.is_vhdl)
+		probe.buf.assign(probe.bit_width, 0);
 	else
-		buf_size = ((bit_width + 31) / 32) * 8;
+		probe.buf.assign(((probe.bit_width + 31) / 32) * 8, 0);
 
-	std::vector<unsigned char> buf(buf_size, 0);
+	return probe;
+}
 
-	_getValue(_uas, hdlObj, buf.data(), nullptr, 0, 0,
+void Loader::_read_probe_raw(Probe &probe) {
+	_getValue(_uas, probe.hdl.data(), probe.buf.data(), nullptr, 0, 0,
 		nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+}
 
-	return decode_value(buf.data(), bit_width, is_vhdl);
+std::string Loader::_read_hier_signal(unsigned id) {
+	Probe probe = _probe_for_id(id);
+	_read_probe_raw(probe);
+	return decode_value(probe.buf.data(), probe.bit_width, probe.is_vhdl);
+}
+
+Loader::Probe Loader::make_probe(const std::string &name) {
+	Probe probe = _probe_for_id(resolve_hier(name));
+	probe.name = name;
+	return probe;
+}
+
+void Loader::read_probe(Probe &probe, uint64_t *val, uint64_t *unk) {
+	_read_probe_raw(probe);
+
+	size_t words = probe.words();
+	std::fill(val, val + words, 0);
+	std::fill(unk, unk + words, 0);
+
+	if(probe.is_vhdl) {
+		// One std_logic per byte, MSB first
+		const unsigned char *data = probe.buf.data();
+		for(unsigned n = 0; n < probe.bit_width; n++) {
+			unsigned char slv = data[probe.bit_width - 1 - n];
+			if(slv == SLV_1 || slv == SLV_H)
+				val[n/64] |= 1ULL << (n&63);
+			else if(slv != SLV_0 && slv != SLV_L)
+				unk[n/64] |= 1ULL << (n&63);
+		}
+	} else {
+		// aVal/bVal pairs, 32 bits at a time, LSB first
+		auto *lv = reinterpret_cast<const s_xsi_vlog_logicval*>(probe.buf.data());
+		for(unsigned w = 0; w < (probe.bit_width + 31) / 32; w++) {
+			uint64_t a = lv[w].aVal, b = lv[w].bVal;
+			unsigned shift = (w & 1) * 32;
+			val[w/2] |= (a & ~b) << shift;
+			unk[w/2] |= b << shift;
+		}
+		if(probe.bit_width & 63) {
+			uint64_t mask = (1ULL << (probe.bit_width & 63)) - 1;
+			val[words-1] &= mask;
+			unk[words-1] &= mask;
+		}
+	}
+}
+
+Loader::EdgeDetector::EdgeDetector(Loader &loader, const std::string &clock) :
+	_loader(&loader),
+	_probe(loader.make_probe(clock))
+{
+	if(_probe.bit_width != 1)
+		throw std::invalid_argument(fmt::format(
+			"Clock '{}' must be a single bit, not {} bits.",
+			clock, _probe.bit_width));
+	_prev = _level();
+}
+
+int Loader::EdgeDetector::_level() {
+	uint64_t val, unk;
+	_loader->read_probe(_probe, &val, &unk);
+	return unk ? -1 : (int)val;
+}
+
+bool Loader::EdgeDetector::rising() {
+	int now = _level();
+	bool edge = (_prev == 0 && now == 1);
+	_prev = now;
+	return edge;
+}
+
+void Loader::EdgeDetector::reset() {
+	_prev = _level();
 }
 
 int Loader::resolve_port(const std::string &name) {
@@ -399,9 +568,113 @@ void Loader::set_signal_value(const std::string &name, uint64_t value) {
 }
 
 std::vector<std::string> Loader::list_signals() {
-	std::vector<std::string> names;
-	names.reserve(_name_to_id.size());
-	for(const auto &[name, id] : _name_to_id)
-		names.push_back(name);
-	return names;
+	return std::vector<std::string>(_sorted_names.begin(), _sorted_names.end());
+}
+
+// Return up to "limit" entries of a sorted view, starting after "after".
+static std::vector<std::string> page(const std::vector<std::string_view> &names,
+		const std::string &after, size_t limit) {
+	auto it = after.empty() ? names.begin()
+		: std::upper_bound(names.begin(), names.end(), std::string_view(after));
+
+	std::vector<std::string> result;
+	for(; it != names.end() && (!limit || result.size() < limit); ++it)
+		result.emplace_back(*it);
+	return result;
+}
+
+const Loader::ScopeNode &Loader::_scope_node(const std::string &scope) const {
+	std::string_view path = scope;
+	if(path.ends_with('/'))
+		path.remove_suffix(1);
+
+	auto it = _scopes.find(path);
+	if(it == _scopes.end())
+		throw std::runtime_error(fmt::format(
+			"Scope '{}' not found in hierarchy.", scope));
+	return it->second;
+}
+
+std::vector<std::string> Loader::children(const std::string &scope,
+		const std::string &after, size_t limit) {
+	return page(_scope_node(scope).children, after, limit);
+}
+
+std::vector<std::string> Loader::signals(const std::string &scope,
+		const std::string &after, size_t limit) {
+	return page(_scope_node(scope).signals, after, limit);
+}
+
+// Does the regex have a '|' outside every group and bracket expression?
+static bool has_toplevel_alternation(const std::string &pattern) {
+	int depth = 0;
+	for(size_t n = 0; n < pattern.size(); n++) {
+		switch(pattern[n]) {
+			case '\\':
+				n++;	/* skip the escaped character */
+				break;
+			case '[':
+				// Skip the bracket expression; a leading ']' is literal
+				n += (n + 1 < pattern.size() && pattern[n+1] == ']') ? 2 : 1;
+				while(n < pattern.size() && pattern[n] != ']')
+					n += (pattern[n] == '\\') ? 2 : 1;
+				break;
+			case '(': depth++; break;
+			case ')': depth--; break;
+			case '|':
+				if(depth == 0)
+					return true;
+				break;
+		}
+	}
+	return false;
+}
+
+// Longest literal string every match of a '^'-anchored regex starts with.
+static std::string regex_literal_prefix(const std::string &pattern) {
+	std::string prefix;
+	if(!pattern.starts_with('^') || has_toplevel_alternation(pattern))
+		return prefix;
+
+	for(size_t n = 1; n < pattern.size(); n++) {
+		char c = pattern[n];
+		if(std::string_view(".[](){}*+?^$\\").find(c) != std::string_view::npos) {
+			// A quantifier makes the preceding character optional
+			if(!prefix.empty() && (c == '*' || c == '?' || c == '{'))
+				prefix.pop_back();
+			break;
+		}
+		prefix += c;
+	}
+	return prefix;
+}
+
+std::vector<std::string> Loader::find(const std::string &pattern, bool regex,
+		const std::string &after, size_t limit) {
+	// Only names sharing the pattern's literal prefix need to be tested.
+	std::optional<std::regex> re;
+	std::string prefix;
+	if(regex) {
+		re.emplace(pattern);
+		prefix = regex_literal_prefix(pattern);
+	} else
+		prefix = pattern.substr(0, pattern.find_first_of("*?[\\"));
+
+	auto it = std::lower_bound(_sorted_names.begin(), _sorted_names.end(),
+		std::string_view(prefix));
+	if(!after.empty())
+		it = std::max(it, std::upper_bound(_sorted_names.begin(), _sorted_names.end(),
+			std::string_view(after)));
+
+	std::vector<std::string> result;
+	for(; it != _sorted_names.end() && it->starts_with(prefix)
+			&& (!limit || result.size() < limit); ++it) {
+		// Views span whole map keys, so data() is NUL-terminated.
+		bool match = regex
+			? std::regex_search(it->begin(), it->end(), *re)
+			: fnmatch(pattern.c_str(), it->data(), FNM_PATHNAME) == 0;
+		if(match)
+			result.emplace_back(*it);
+	}
+	return result;
 }
@@ -3,7 +3,9 @@
 #include "xsi.h"
 #include <dlfcn.h>
 
+#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <stdexcept>
@@ -46,14 +48,19 @@ namespace Xsi {
 				if(!isopen())
 					throw std::runtime_error("Design not open! Can't execute XSI method.");
 				_xsi_run(_design_handle, step);
+				_time += step;
 			}
 
 			void restart() {
 				if(!isopen())
 					throw std::runtime_error("Design not open! Can't execute XSI method.");
 				_xsi_restart(_design_handle);
+				_time = 0;
 			}
 
+			// Simulation time elapsed via run(), in simulator resolution units
+			XSI_INT64 time() const { return _time; }
+
 			void put_value(int port_number, const void* value){
 				_xsi_put_value(_design_handle, port_number, const_cast<void*>(value));
 			}
@@ -105,6 +112,56 @@ namespace Xsi {
 			void set_signal_value(const std::string &name, uint64_t value);
 			std::vector<std::string> list_signals();
 
+			// Scope-tree queries, served from a sorted index built by
+			// init_hierarchy(). Results are in name order; pass the last
+			// name of one page as "after" to fetch the next. limit=0 means
+			// no limit. Globs match one level at a time: '*' and '?' never
+			// match '/', so "/top/*" is only top's own signals.
+			std::vector<std::string> children(const std::string &scope,
+				const std::string &after="", size_t limit=0);
+			std::vector<std::string> signals(const std::string &scope,
+				const std::string &after="", size_t limit=0);
+			std::vector<std::string> find(const std::string &pattern, bool regex=false,
+				const std::string &after="", size_t limit=0);
+
+			// A signal resolved once up front, for samplers that read it
+			// every cycle without going through string names.
+			struct Probe {
+				std::string name;
+				unsigned id = 0;
+				unsigned bit_width = 0;
+				bool is_vhdl = false;
+				std::vector<unsigned char> hdl;	// opaque HdlValueObject
+				std::vector<unsigned char> buf;	// raw value scratch
+
+				size_t words() const { return (bit_width + 63) / 64; }
+			};
+
+			Probe make_probe(const std::string &name);
+
+			// Read a probe as packed little-endian bits: val holds the
+			// 0/1 value, unk flags bits that are neither (X, Z, U, ...).
+			// Both must hold probe.words() words.
+			void read_probe(Probe &probe, uint64_t *val, uint64_t *unk);
+
+			// Watches a single-bit clock for 0->1 transitions between calls
+			// to rising(). Unknown levels never count as either side of one.
+			// The level is first taken on construction, and again by reset()
+			// after the simulator restarts.
+			class EdgeDetector {
+				public:
+					EdgeDetector(Loader &loader, const std::string &clock);
+					bool rising();
+					void reset();
+
+				private:
+					int _level();	// 0, 1, or -1 if unknown
+
+					Loader *_loader;
+					Probe _probe;
+					int _prev = -1;
+			};
+
 		private:
 			void *design, *simkernel;
 
@@ -112,6 +169,7 @@ namespace Xsi {
 			std::string _simkernel_libname;
 			xsiHandle _design_handle;
 			int _num_ports = 0;
+			XSI_INT64 _time = 0;
 
 			// XSI function pointers (resolved from design/simkernel .so)
 			t_fp_xsi_open _xsi_open;
@@ -160,6 +218,11 @@ namespace Xsi {
 
 			int resolve_port(const std::string &name);
 			void enumerate_scope(unsigned scope_id);
+			void build_index();
+			void _name_scope(unsigned id, std::unordered_map<unsigned, std::string> &paths);
+			unsigned resolve_hier(const std::string &name);
+			Probe _probe_for_id(unsigned id);
+			void _read_probe_raw(Probe &probe);
 			std::string _read_hier_signal(unsigned id);
 
 			void *_dbg = nullptr;
@@ -167,5 +230,23 @@ namespace Xsi {
 
 			std::unordered_map<std::string, unsigned> _name_to_id;
 			std::unordered_map<std::string, std::string> _port_to_hier;
+
+			// Sorted views onto _name_to_id's keys (which never move), and
+			// each scope's direct children and signals, keyed by scope path.
+			struct ScopeNode {
+				std::vector<std::string_view> children;
+				std::vector<std::string_view> signals;
+			};
+			std::vector<std::string_view> _sorted_names;
+
+			// What enumerate_scope() saw of each scope id; only kept
+			// until build_index() has turned it into _scopes.
+			struct ScopeWalk {
+				std::vector<unsigned> children;
+				std::vector<std::string_view> objects;
+			};
+			std::unordered_map<unsigned, ScopeWalk> _scope_walk;
+			std::map<std::string, ScopeNode, std::less<>> _scopes;
+			const ScopeNode &_scope_node(const std::string &scope) const;
 	};
 }